@@ -0,0 +1,157 @@
+#ifndef THREAD_ARENA
+#define THREAD_ARENA
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// 线程私有的线性分配器（bump-pointer），供任务分配短生命周期的临时内存
+// 继承 std::pmr::memory_resource，可直接作为 std::pmr 容器的内存资源
+// 非线程安全，只能在所属工作线程中使用
+class ThreadArena : public std::pmr::memory_resource
+{
+public:
+    explicit ThreadArena(size_t nBlockSize = 64 * 1024, size_t nMaxRetainBlockNum = 4);
+    ~ThreadArena();
+
+    ThreadArena(const ThreadArena &) = delete;
+    ThreadArena &operator=(const ThreadArena &) = delete;
+
+    // 释放本次任务中分配的所有内存，最多保留nMaxRetainBlockNum个普通内存块以便下个任务复用
+    void Reset();
+
+    // 当前已分配出去的字节数
+    size_t nUsedBytes() const;
+
+protected:
+    void *do_allocate(size_t nBytes, size_t nAlign) override;
+    void do_deallocate(void *p, size_t nBytes, size_t nAlign) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+private:
+    struct Block
+    {
+        std::byte *pData; // 内存块起始地址
+        size_t nSize; // 内存块大小
+    };
+
+    size_t m_nBlockSize; // 普通内存块大小
+    size_t m_nMaxRetainBlockNum; // Reset后最多保留的普通内存块数量
+    std::vector<Block> m_vecBlock; // 可复用的普通内存块
+    std::vector<Block> m_vecLargeBlock; // 超过普通块大小的单独分配，Reset时释放
+    size_t m_nCurBlock; // 当前正在使用的普通块下标
+    size_t m_nOffset; // 当前普通块中已使用的偏移
+    size_t m_nUsedBytes; // 已分配出去的字节数
+
+    static Block NewBlock(size_t nSize);
+    static void DeleteBlock(const Block &block);
+};
+
+inline ThreadArena::ThreadArena(size_t nBlockSize, size_t nMaxRetainBlockNum)
+    : m_nBlockSize(nBlockSize)
+    , m_nMaxRetainBlockNum(nMaxRetainBlockNum > 0 ? nMaxRetainBlockNum : 1)
+    , m_nCurBlock(0)
+    , m_nOffset(0)
+    , m_nUsedBytes(0)
+{
+    m_vecBlock.push_back(NewBlock(m_nBlockSize));
+}
+
+inline ThreadArena::~ThreadArena()
+{
+    for (const Block &block : m_vecBlock)
+    {
+        DeleteBlock(block);
+    }
+    for (const Block &block : m_vecLargeBlock)
+    {
+        DeleteBlock(block);
+    }
+}
+
+inline void ThreadArena::Reset()
+{
+    for (const Block &block : m_vecLargeBlock)
+    {
+        DeleteBlock(block);
+    }
+    m_vecLargeBlock.clear();
+    // 单个任务用量过大时只保留前几块，避免峰值内存一直被占用
+    while (m_vecBlock.size() > m_nMaxRetainBlockNum)
+    {
+        DeleteBlock(m_vecBlock.back());
+        m_vecBlock.pop_back();
+    }
+    m_nCurBlock = 0;
+    m_nOffset = 0;
+    m_nUsedBytes = 0;
+}
+
+inline size_t ThreadArena::nUsedBytes() const
+{
+    return m_nUsedBytes;
+}
+
+inline void *ThreadArena::do_allocate(size_t nBytes, size_t nAlign)
+{
+    // 请求大小加上对齐后溢出时无法满足
+    if (nBytes > std::numeric_limits<size_t>::max() - nAlign)
+    {
+        throw std::bad_alloc();
+    }
+    // 大块内存单独分配，避免浪费普通块
+    if (nBytes + nAlign > m_nBlockSize)
+    {
+        Block block = NewBlock(nBytes + nAlign);
+        m_vecLargeBlock.push_back(block);
+        m_nUsedBytes += nBytes;
+        void *p = block.pData;
+        size_t nSpace = block.nSize;
+        return std::align(nAlign, nBytes, p, nSpace);
+    }
+
+    while (true)
+    {
+        Block &block = m_vecBlock[m_nCurBlock];
+        void *p = block.pData + m_nOffset;
+        size_t nSpace = block.nSize - m_nOffset;
+        if (std::align(nAlign, nBytes, p, nSpace) != nullptr)
+        {
+            m_nOffset = static_cast<std::byte *>(p) - block.pData + nBytes;
+            m_nUsedBytes += nBytes;
+            return p;
+        }
+        // 当前块放不下，切换到下一块，没有可复用的块则新建
+        m_nCurBlock++;
+        m_nOffset = 0;
+        if (m_nCurBlock == m_vecBlock.size())
+        {
+            m_vecBlock.push_back(NewBlock(m_nBlockSize));
+        }
+    }
+}
+
+inline void ThreadArena::do_deallocate(void *, size_t, size_t)
+{
+    // 线性分配器不单独释放，统一在Reset时回收
+}
+
+inline bool ThreadArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+inline ThreadArena::Block ThreadArena::NewBlock(size_t nSize)
+{
+    return Block{static_cast<std::byte *>(::operator new(nSize)), nSize};
+}
+
+inline void ThreadArena::DeleteBlock(const Block &block)
+{
+    ::operator delete(block.pData);
+}
+
+#endif
@@ -1,67 +1,125 @@
 #ifndef THREAD_POOL
 #define THREAD_POOL
 
-#include <queue>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <functional>
 #include <future>
 #include <condition_variable>
 #include <mutex>
 #include <memory>
+#include <memory_resource>
+#include "ThreadArena.h"
+#include "TwoLockQueue.h"
 
 using ThreadPoolTask = std::function<void()>;
 
 class ThreadPool
 {
 public:
-    ThreadPool(int nThreadNum = 4);
+    // nThreadNum小于1时按1个线程处理
+    ThreadPool(int nThreadNum = 4, size_t nArenaBlockSize = 64 * 1024);
     ~ThreadPool();
 
     // 将线程存入线程池
 	template <typename Func, typename... Args>
 	auto PushThread(Func &&func, Args &&...args) -> std::future<typename std::result_of<Func(Args...)>::type>;
 
+	// 将线程存入指定工作线程的专属队列，只由该工作线程执行，下标超出范围时对线程总数取模
+	template <typename Func, typename... Args>
+	auto PushThreadOn(int nWorkerIndex, Func &&func, Args &&...args) -> std::future<typename std::result_of<Func(Args...)>::type>;
+
+	// 按key将线程分配给固定的工作线程，相同key的任务在同一线程上按提交顺序串行执行
+	// key的哈希值会先打散再取模，避免步长为线程数倍数的整数key集中到同一线程
+	template <typename Key, typename Func, typename... Args>
+	auto PushKeyed(const Key &key, Func &&func, Args &&...args) -> std::future<typename std::result_of<Func(Args...)>::type>;
+
 	// 等待线程池中所有线程运算完毕
     void vWaitAllThreadFinish();
 
     // 获取线程池中所有线程运算是否完毕
     bool bIsThreadAllDone();
 
+    // 获取当前工作线程的临时内存分配器，每个任务结束后自动重置，不在工作线程中时返回nullptr
+    // 任务中分配的内存不能在任务结束后继续使用
+    static ThreadArena *CurrentArena();
+
+    // 获取供std::pmr容器使用的内存资源，不在工作线程中时返回默认内存资源
+    static std::pmr::memory_resource *CurrentMemoryResource();
+
 private:
-    int m_nThreadWorkingNum; // 正在工作的线程数量
+    // 每个工作线程独立的专属队列和唤醒条件，按缓存行对齐避免伪共享
+    struct alignas(64) WorkerContext
+    {
+        TwoLockQueue<ThreadPoolTask> queueInbox; // 只由该线程执行的任务
+        std::atomic<bool> bIdle; // 是否正在等待任务
+        std::condition_variable condWake; // 该线程等待新任务
+        std::mutex mutexWake; // 配合condWake使用
+        WorkerContext() : bIdle(false) {}
+    };
+
+    static constexpr int INBOX_BATCH_NUM = 8; // 连续执行多少个专属任务后优先取一次共享任务
+
+    std::atomic<int> m_nUnfinishedJobNum; // 已提交但尚未执行完毕的任务数量
     int m_nTotalThreadNum; // 总线程数量
-    bool m_bRunning; // 代表所有线程池是否在运行
-    std::queue<ThreadPoolTask> m_queueJob; // 任务队列
-    std::condition_variable m_Condition; // 线程等待锁
-    std::mutex m_mutexJob; // 为任务加锁防止一个任务被两个线程执行等其他情况
+    std::atomic<bool> m_bRunning; // 代表所有线程池是否在运行
+    TwoLockQueue<ThreadPoolTask> m_queueJob; // 共享任务队列，入队和出队分别加锁
+    std::vector<std::unique_ptr<WorkerContext>> m_vecWorker; // 每个工作线程的上下文
+    std::atomic<int> m_nFinishWaiterNum; // 正在等待所有任务完成的线程数量
+    std::condition_variable m_condFinish; // vWaitAllThreadFinish等待所有任务完成
+    std::mutex m_mutexFinish; // 配合m_condFinish使用
     std::vector<std::thread> m_vecThread; // 所有工作线程的容器
+    size_t m_nArenaBlockSize; // 工作线程临时内存分配器的内存块大小
+    inline static thread_local ThreadArena *s_pCurrentArena = nullptr; // 当前工作线程的临时内存分配器
+
+    // 打包任务并放入队列，nWorkerIndex为-1时放入共享队列，否则放入对应工作线程的专属队列
+    template <typename Func, typename... Args>
+    auto PushJob(int nWorkerIndex, Func &&func, Args &&...args) -> std::future<typename std::result_of<Func(Args...)>::type>;
+
+    // 唤醒一个正在等待的工作线程，返回是否成功唤醒
+    bool bWakeWorker(WorkerContext &worker);
+
+    // 未完成任务计数减一，减到0时唤醒vWaitAllThreadFinish的等待者
+    void vFinishJob();
 
     // 具体工作线程
-    void vThreadLoop();
+    void vThreadLoop(int nWorkerIndex);
 };
 
-inline ThreadPool::ThreadPool(int nThreadNum)
-    : m_nTotalThreadNum(nThreadNum)
-    , m_nThreadWorkingNum(0)
+inline ThreadPool::ThreadPool(int nThreadNum, size_t nArenaBlockSize)
+    : m_nUnfinishedJobNum(0)
+    , m_nTotalThreadNum(nThreadNum > 0 ? nThreadNum : 1)
+    , m_nFinishWaiterNum(0)
+    , m_nArenaBlockSize(nArenaBlockSize)
 {
     // 启动线程
-    m_bRunning = true;
-    // 初始化工作线程
-    for (size_t i = 0; i < m_nTotalThreadNum; i++)
+    m_bRunning.store(true);
+    // 初始化工作线程，上下文必须在线程启动前全部创建好
+    for (int i = 0; i < m_nTotalThreadNum; i++)
+    {
+        m_vecWorker.push_back(std::make_unique<WorkerContext>());
+    }
+    for (int i = 0; i < m_nTotalThreadNum; i++)
     {
         // 为每个工作节点创建一条线程
-        m_vecThread.push_back(std::thread(&ThreadPool::vThreadLoop, this));
+        m_vecThread.push_back(std::thread(&ThreadPool::vThreadLoop, this, i));
     }
 }
 
 inline ThreadPool::~ThreadPool()
 {
-    // 关闭管理线程，必须要大括号限制作用域，否则死锁
+    // 关闭管理线程，加锁后再通知，保证等待中的线程不会错过m_bRunning的变化
+    m_bRunning.store(false);
+    for (std::unique_ptr<WorkerContext> &worker : m_vecWorker)
+    {
+        std::unique_lock<std::mutex> lock(worker->mutexWake);
+        worker->condWake.notify_all();
+    }
     {
-        std::unique_lock<std::mutex> lock(m_mutexJob);
-        m_bRunning = false;
+        std::unique_lock<std::mutex> lock(m_mutexFinish);
+        m_condFinish.notify_all();
     }
-    m_Condition.notify_all();
 
     for (size_t i = 0; i < m_nTotalThreadNum; i++)
     {
@@ -75,6 +133,38 @@ inline ThreadPool::~ThreadPool()
 template <typename Func, typename... Args>
 inline auto ThreadPool::PushThread(Func&& func, Args&&... args) 
         -> std::future<typename std::result_of<Func(Args...)>::type>
+    {
+        return PushJob(-1, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+template <typename Func, typename... Args>
+inline auto ThreadPool::PushThreadOn(int nWorkerIndex, Func&& func, Args&&... args) 
+        -> std::future<typename std::result_of<Func(Args...)>::type>
+    {
+        nWorkerIndex %= m_nTotalThreadNum;
+        if (nWorkerIndex < 0)
+        {
+            nWorkerIndex += m_nTotalThreadNum;
+        }
+        return PushJob(nWorkerIndex, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+template <typename Key, typename Func, typename... Args>
+inline auto ThreadPool::PushKeyed(const Key &key, Func&& func, Args&&... args) 
+        -> std::future<typename std::result_of<Func(Args...)>::type>
+    {
+        // std::hash对整数通常是恒等映射，用splitmix64的混合步骤打散低位
+        uint64_t nHash = std::hash<Key>{}(key);
+        nHash = (nHash ^ (nHash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        nHash = (nHash ^ (nHash >> 27)) * 0x94d049bb133111ebULL;
+        nHash = nHash ^ (nHash >> 31);
+        int nWorkerIndex = static_cast<int>(nHash % m_nTotalThreadNum);
+        return PushJob(nWorkerIndex, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+template <typename Func, typename... Args>
+inline auto ThreadPool::PushJob(int nWorkerIndex, Func&& func, Args&&... args) 
+        -> std::future<typename std::result_of<Func(Args...)>::type>
     {
         using ReturnType = typename std::result_of<Func(Args...)>::type;
         using TaskType = std::packaged_task<ReturnType()>;
@@ -85,68 +175,153 @@ inline auto ThreadPool::PushThread(Func&& func, Args&&... args)
         );
         
         std::future<ReturnType> res = task->get_future();
+        // 先计数再入队，保证工作线程执行完任务时计数已包含该任务
+        m_nUnfinishedJobNum.fetch_add(1);
+        try
+        {
+            if (nWorkerIndex >= 0)
+            {
+                m_vecWorker[nWorkerIndex]->queueInbox.push([task]() { (*task)(); });
+            }
+            else
+            {
+                m_queueJob.push([task]() { (*task)(); });
+            }
+        }
+        catch (...)
         {
-            std::unique_lock<std::mutex> lock(m_mutexJob);
-            m_queueJob.push([task]() { (*task)(); });
+            // 入队时分配内存失败，撤销计数，否则vWaitAllThreadFinish会一直等待
+            vFinishJob();
+            throw;
+        }
+        if (nWorkerIndex >= 0)
+        {
+            // 专属任务只能由目标线程执行，目标线程空闲时唤醒它
+            bWakeWorker(*m_vecWorker[nWorkerIndex]);
+            return res;
+        }
+        // 只有存在空闲线程时才去唤醒，且只唤醒一个
+        for (std::unique_ptr<WorkerContext> &worker : m_vecWorker)
+        {
+            if (bWakeWorker(*worker))
+            {
+                break;
+            }
         }
-        m_Condition.notify_one();
         return res;
     }
 
-inline void ThreadPool::vThreadLoop()
+inline bool ThreadPool::bWakeWorker(WorkerContext &worker)
+{
+    // 先只读检查，忙碌线程的上下文不做写操作，避免缓存行在核间来回传递
+    if (!worker.bIdle.load())
+    {
+        return false;
+    }
+    // 把空闲标记清掉，避免多个入队线程重复唤醒同一个线程
+    if (!worker.bIdle.exchange(false))
+    {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(worker.mutexWake);
+    worker.condWake.notify_one();
+    return true;
+}
+
+inline void ThreadPool::vThreadLoop(int nWorkerIndex)
 {
-    while (m_bRunning)
+    WorkerContext &worker = *m_vecWorker[nWorkerIndex];
+    // 每个工作线程独占一个临时内存分配器
+    ThreadArena arena(m_nArenaBlockSize);
+    s_pCurrentArena = &arena;
+    int nInboxRunNum = 0; // 连续执行的专属任务数量
+    while (m_bRunning.load())
     {
-        ThreadPoolTask job;
+        // 优先执行专属任务，没有时再从共享队列中取任务
+        // 连续执行INBOX_BATCH_NUM个专属任务后先取一次共享任务，避免共享任务被饿死，专属队列仍按先进先出执行
+        // 获取到job后将该job从任务队列移出，免得其他worker过来重复做这个任务
+        std::optional<ThreadPoolTask> job;
+        if (nInboxRunNum >= INBOX_BATCH_NUM)
         {
-            std::unique_lock<std::mutex> lock(m_mutexJob);
-            m_Condition.wait_for(lock, std::chrono::milliseconds(5), [this]() { return !m_bRunning || m_queueJob.size() != 0; });
-             // 检查worker是否需要结束生命
-            if (!m_bRunning)
-            {
-                break;
-            }
-            if (m_queueJob.size() != 0)
+            job = m_queueJob.pop();
+            nInboxRunNum = 0;
+        }
+        if (!job.has_value())
+        {
+            job = worker.queueInbox.pop();
+            if (job.has_value())
             {
-                 // 获取到job后将该job从任务队列移出，免得其他worker过来重复做这个任务
-                job = std::move(m_queueJob.front());
-                 // 弹出任务队列
-                m_queueJob.pop();
-                m_nThreadWorkingNum++;
+                nInboxRunNum++;
             }
-            else
+        }
+        if (!job.has_value())
+        {
+            job = m_queueJob.pop();
+            nInboxRunNum = 0;
+        }
+        if (!job.has_value())
+        {
+            // 队列为空时阻塞等待，入队线程看到空闲标记后才会唤醒
+            // 只在即将等待前标记空闲，被唤醒后到检查完队列前都不算空闲，避免其他入队线程误把唤醒算到本线程头上
+            std::unique_lock<std::mutex> lock(worker.mutexWake);
+            while (m_bRunning.load() && worker.queueInbox.size() == 0 && m_queueJob.size() == 0)
             {
-                lock.unlock();
-                m_Condition.notify_all();
-                continue;
+                worker.bIdle.store(true);
+                // 标记空闲后再检查一次，防止与入队线程交错时错过唤醒
+                if (!m_bRunning.load() || worker.queueInbox.size() > 0 || m_queueJob.size() > 0)
+                {
+                    worker.bIdle.store(false);
+                    break;
+                }
+                worker.condWake.wait(lock);
+                worker.bIdle.store(false);
             }
+            continue;
         }
          // 执行任务
-        job();
-        std::unique_lock<std::mutex> lock(m_mutexJob);
-        m_nThreadWorkingNum--;
-        if (m_queueJob.size() == 0)
-        {
-            lock.unlock();
-            m_Condition.notify_all();
-        }
+        job.value()();
+        job.reset();
+        arena.Reset();
+        vFinishJob();
     }
+    s_pCurrentArena = nullptr;
 }
 
-inline void ThreadPool::vWaitAllThreadFinish()
+inline void ThreadPool::vFinishJob()
 {
-    std::unique_lock<std::mutex> lock(m_mutexJob);
-    do
+    // 最后一个任务完成时才唤醒等待者
+    if (m_nUnfinishedJobNum.fetch_sub(1) == 1 && m_nFinishWaiterNum.load() > 0)
     {
-        m_Condition.wait_for(lock, std::chrono::milliseconds(5), [this]() { return !m_bRunning || (m_queueJob.size() == 0 && m_nThreadWorkingNum == 0); });
-    } while (m_bRunning && (m_queueJob.size() != 0 || m_nThreadWorkingNum != 0));
-    return ;
+        std::unique_lock<std::mutex> lock(m_mutexFinish);
+        m_condFinish.notify_all();
+    }
+}
+
+inline void ThreadPool::vWaitAllThreadFinish()
+{
+    std::unique_lock<std::mutex> lock(m_mutexFinish);
+    m_nFinishWaiterNum.fetch_add(1);
+    m_condFinish.wait(lock, [this]() { return !m_bRunning.load() || m_nUnfinishedJobNum.load() == 0; });
+    m_nFinishWaiterNum.fetch_sub(1);
 }
 
 inline bool ThreadPool::bIsThreadAllDone()
 {
-    std::unique_lock<std::mutex> lock(m_mutexJob);
-    return m_queueJob.size() == 0 && m_nThreadWorkingNum == 0;
+    return m_nUnfinishedJobNum.load() == 0;
+}
+
+inline ThreadArena *ThreadPool::CurrentArena()
+{
+    return s_pCurrentArena;
+}
+
+inline std::pmr::memory_resource *ThreadPool::CurrentMemoryResource()
+{
+    if (s_pCurrentArena == nullptr)
+    {
+        return std::pmr::get_default_resource();
+    }
+    return s_pCurrentArena;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef TWO_LOCK_QUEUE
+#define TWO_LOCK_QUEUE
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+
+// 双锁队列：队头和队尾各用一把锁，入队和出队互不阻塞
+template <typename T>
+class TwoLockQueue
+{
+private:
+    struct QueueNode
+    {
+        std::optional<T> data;
+        std::atomic<QueueNode *> next;
+        QueueNode() : data(std::nullopt), next(nullptr) {}
+        explicit QueueNode(T const& value) : data(value), next(nullptr) {}
+        explicit QueueNode(T&& value) : data(std::move(value)), next(nullptr) {}
+    };
+
+public:
+    TwoLockQueue();
+    ~TwoLockQueue();
+
+    TwoLockQueue(const TwoLockQueue &) = delete;
+    TwoLockQueue &operator=(const TwoLockQueue &) = delete;
+
+    std::optional<T> pop();
+
+    void push(const T &value);
+    void push(T &&value);
+    int size();
+    void clear();
+
+private:
+    void PushNode(QueueNode *newNode);
+
+    QueueNode *m_head; // 队头哨兵节点，只在持有m_mutexHead时访问
+    QueueNode *m_tail; // 队尾节点，只在持有m_mutexTail时访问
+    std::mutex m_mutexHead; // 出队锁
+    std::mutex m_mutexTail; // 入队锁
+    std::atomic<int> m_size;
+};
+
+template <typename T>
+inline TwoLockQueue<T>::TwoLockQueue()
+{
+    QueueNode *dummy = new QueueNode();
+    m_head = dummy;
+    m_tail = dummy;
+    m_size.store(0);
+}
+
+template <typename T>
+inline TwoLockQueue<T>::~TwoLockQueue()
+{
+    QueueNode *nDelete = m_head;
+    QueueNode *nextDelete;
+    while (nDelete)
+    {
+        nextDelete = nDelete->next.load(std::memory_order_relaxed);
+        delete nDelete;
+        nDelete = nextDelete;
+    }
+}
+
+template <typename T>
+inline std::optional<T> TwoLockQueue<T>::pop()
+{
+    QueueNode *oldHead;
+    std::optional<T> res;
+    {
+        std::unique_lock<std::mutex> lock(m_mutexHead);
+        oldHead = m_head;
+        // 队列只剩哨兵节点时为空，next与入队线程之间通过原子变量同步
+        QueueNode *newHead = oldHead->next.load(std::memory_order_acquire);
+        if (newHead == nullptr)
+        {
+            return std::nullopt;
+        }
+        // 新的队头成为哨兵节点，取走其中的数据
+        res = std::move(newHead->data);
+        newHead->data.reset();
+        m_head = newHead;
+        m_size.fetch_sub(1);
+    }
+    // 旧哨兵节点已不会被其他线程访问，在锁外释放
+    delete oldHead;
+    return res;
+}
+
+template <typename T>
+inline void TwoLockQueue<T>::push(const T &value)
+{
+    PushNode(new QueueNode(value));
+}
+
+template <typename T>
+inline void TwoLockQueue<T>::push(T &&value)
+{
+    PushNode(new QueueNode(std::move(value)));
+}
+
+template <typename T>
+inline int TwoLockQueue<T>::size()
+{
+    return m_size.load();
+}
+
+template <typename T>
+inline void TwoLockQueue<T>::clear()
+{
+    while (pop().has_value());
+}
+
+template <typename T>
+inline void TwoLockQueue<T>::PushNode(QueueNode *newNode)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutexTail);
+        m_tail->next.store(newNode, std::memory_order_release);
+        m_tail = newNode;
+    }
+    m_size.fetch_add(1);
+}
+
+#endif
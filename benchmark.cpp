@@ -0,0 +1,252 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory_resource>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include "ThreadPool.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// 编译：g++ -std=c++17 -O2 -pthread benchmark.cpp -o benchmark
+
+const int TASK_NUM = 20000; // 每轮测试提交的任务数
+const int ITEM_NUM = 256; // 每个任务中临时容器的元素数
+
+// 在任务中使用大量临时的vector和string
+size_t ScratchTask(std::pmr::memory_resource *pResource, int nSeed)
+{
+    std::pmr::vector<std::pmr::string> vecStr(pResource);
+    std::pmr::vector<int> vecNum(pResource);
+    for (int i = 0; i < ITEM_NUM; i++)
+    {
+        std::pmr::string str(pResource);
+        str.append("scratch buffer item ");
+        str.append(std::to_string(nSeed + i));
+        vecStr.push_back(std::move(str));
+        vecNum.push_back(nSeed * i);
+    }
+    size_t nTotal = 0;
+    for (const std::pmr::string &str : vecStr)
+    {
+        nTotal += str.size();
+    }
+    return nTotal + vecNum.size();
+}
+
+// 获取当前进程累计的上下文切换次数（自愿+非自愿），不支持的平台返回-1
+long lContextSwitchNum()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+#else
+    return -1;
+#endif
+}
+
+template <typename Func>
+double RunBenchmark(Func &&func)
+{
+    ThreadPool pool;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TASK_NUM; i++)
+    {
+        pool.PushThread(func, i);
+    }
+    pool.vWaitAllThreadFinish();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void BenchmarkArena()
+{
+    double dDefault = RunBenchmark([](int nSeed) { return ScratchTask(std::pmr::get_default_resource(), nSeed); });
+    double dArena = RunBenchmark([](int nSeed) { return ScratchTask(ThreadPool::CurrentMemoryResource(), nSeed); });
+    std::cout << "[Arena] default allocator: " << dDefault << " ms\n";
+    std::cout << "[Arena] thread arena:      " << dArena << " ms\n";
+}
+
+// 对照用的旧版线程池：单个互斥锁和条件变量，空队列时notify_all，并以5ms超时轮询
+class ThreadPoolReference
+{
+public:
+    ThreadPoolReference(int nThreadNum = 4)
+        : m_nThreadWorkingNum(0)
+        , m_bRunning(true)
+    {
+        for (int i = 0; i < nThreadNum; i++)
+        {
+            m_vecThread.push_back(std::thread(&ThreadPoolReference::vThreadLoop, this));
+        }
+    }
+
+    ~ThreadPoolReference()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutexJob);
+            m_bRunning = false;
+        }
+        m_Condition.notify_all();
+        for (std::thread &thread : m_vecThread)
+        {
+            thread.join();
+        }
+    }
+
+    template <typename Func, typename... Args>
+    void PushThread(Func &&func, Args &&...args)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutexJob);
+            m_queueJob.push(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        }
+        m_Condition.notify_one();
+    }
+
+    void vWaitAllThreadFinish()
+    {
+        std::unique_lock<std::mutex> lock(m_mutexJob);
+        do
+        {
+            m_Condition.wait_for(lock, std::chrono::milliseconds(5), [this]() { return !m_bRunning || (m_queueJob.size() == 0 && m_nThreadWorkingNum == 0); });
+        } while (m_bRunning && (m_queueJob.size() != 0 || m_nThreadWorkingNum != 0));
+    }
+
+private:
+    int m_nThreadWorkingNum; // 正在工作的线程数量
+    bool m_bRunning; // 代表所有线程池是否在运行
+    std::queue<ThreadPoolTask> m_queueJob; // 任务队列
+    std::condition_variable m_Condition; // 线程等待锁
+    std::mutex m_mutexJob; // 为任务加锁
+    std::vector<std::thread> m_vecThread; // 所有工作线程的容器
+
+    void vThreadLoop()
+    {
+        while (m_bRunning)
+        {
+            ThreadPoolTask job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutexJob);
+                m_Condition.wait_for(lock, std::chrono::milliseconds(5), [this]() { return !m_bRunning || m_queueJob.size() != 0; });
+                if (!m_bRunning)
+                {
+                    break;
+                }
+                if (m_queueJob.size() == 0)
+                {
+                    lock.unlock();
+                    m_Condition.notify_all();
+                    continue;
+                }
+                job = std::move(m_queueJob.front());
+                m_queueJob.pop();
+                m_nThreadWorkingNum++;
+            }
+            job();
+            std::unique_lock<std::mutex> lock(m_mutexJob);
+            m_nThreadWorkingNum--;
+            if (m_queueJob.size() == 0)
+            {
+                lock.unlock();
+                m_Condition.notify_all();
+            }
+        }
+    }
+};
+
+const int BURST_NUM = 2000; // 批次数
+const int BURST_SIZE = 16; // 每批任务数
+
+// 小任务分批提交，每批结束后等待全部完成，统计上下文切换次数
+template <typename Pool>
+void BenchmarkWakeup(const char *szName)
+{
+    Pool pool;
+    std::atomic<long> lSum(0);
+    long lSwitchStart = lContextSwitchNum();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BURST_NUM; i++)
+    {
+        for (int j = 0; j < BURST_SIZE; j++)
+        {
+            pool.PushThread([&lSum](int n) { lSum.fetch_add(n); }, j);
+        }
+        pool.vWaitAllThreadFinish();
+    }
+    auto end = std::chrono::steady_clock::now();
+    long lSwitchEnd = lContextSwitchNum();
+    std::cout << "[Wakeup] " << szName << " " << BURST_NUM << " bursts x " << BURST_SIZE << " tasks: "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms, "
+              << (lSwitchEnd - lSwitchStart) << " context switches\n";
+}
+
+const int SESSION_NUM = 64; // 会话数量
+const int SESSION_COUNTER_NUM = 4096; // 每个会话的计数器数量
+const int UPDATE_NUM = 200000; // 更新任务数
+
+// 每个会话独立的状态，模拟按key处理的对象
+struct Session
+{
+    std::mutex mutexSession; // 不按key分配时需要加锁保护
+    std::vector<long> vecCounter = std::vector<long>(SESSION_COUNTER_NUM, 0);
+};
+
+void UpdateSession(Session &session, int nSeed)
+{
+    for (int i = 0; i < SESSION_COUNTER_NUM; i += 8)
+    {
+        session.vecCounter[i] += nSeed + i;
+    }
+}
+
+// 按会话更新计数器：任意线程执行需要加锁，按key分配则同一会话固定在同一线程上串行执行
+void BenchmarkKeyed()
+{
+    std::vector<Session> vecSession(SESSION_NUM);
+    double dShared = 0;
+    double dKeyed = 0;
+    {
+        ThreadPool pool;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < UPDATE_NUM; i++)
+        {
+            Session &session = vecSession[i % SESSION_NUM];
+            pool.PushThread([&session](int nSeed) {
+                std::unique_lock<std::mutex> lock(session.mutexSession);
+                UpdateSession(session, nSeed);
+            }, i);
+        }
+        pool.vWaitAllThreadFinish();
+        auto end = std::chrono::steady_clock::now();
+        dShared = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    {
+        ThreadPool pool;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < UPDATE_NUM; i++)
+        {
+            int nKey = i % SESSION_NUM;
+            Session &session = vecSession[nKey];
+            pool.PushKeyed(nKey, [&session](int nSeed) { UpdateSession(session, nSeed); }, i);
+        }
+        pool.vWaitAllThreadFinish();
+        auto end = std::chrono::steady_clock::now();
+        dKeyed = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    std::cout << "[Keyed] shared queue + lock: " << dShared << " ms\n";
+    std::cout << "[Keyed] PushKeyed:           " << dKeyed << " ms\n";
+}
+
+int main()
+{
+    BenchmarkArena();
+    BenchmarkWakeup<ThreadPoolReference>("single mutex (reference):");
+    BenchmarkWakeup<ThreadPool>("two-lock queue:          ");
+    BenchmarkKeyed();
+    return 0;
+}
@@ -2,8 +2,16 @@
 #include <windows.h>
 #include <string>
 #include <chrono>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+#include <functional>
 #include "ThreadPool.h"
 #include "ThreadPoolLockFree.h"
+#include "TwoLockQueue.h"
 
 int func1(int i)
 {
@@ -48,10 +56,10 @@ void funcPush(int i)
 
 void funcPop()
 {
-    std::shared_ptr<int> pN = myQueue.pop();
-    if (pN != nullptr)
+    std::optional<int> pN = myQueue.pop();
+    if (pN.has_value())
     {
-        std::string str = std::to_string(*pN.get()) + "\n";
+        std::string str = std::to_string(pN.value()) + "\n";
         std::cout << str;
     }
     else
@@ -60,8 +68,200 @@ void funcPop()
     }
 }
 
+// 检查双锁队列的先进先出顺序和计数
+void TestTwoLockQueue()
+{
+    TwoLockQueue<int> queue;
+    assert(queue.size() == 0);
+    assert(!queue.pop().has_value());
+    for (int i = 0; i < 100; i++)
+    {
+        queue.push(i);
+    }
+    assert(queue.size() == 100);
+    for (int i = 0; i < 50; i++)
+    {
+        std::optional<int> value = queue.pop();
+        assert(value.has_value() && value.value() == i);
+    }
+    assert(queue.size() == 50);
+    queue.clear();
+    assert(queue.size() == 0);
+    assert(!queue.pop().has_value());
+}
+
+// 检查多线程提交、等待全部完成和完成状态
+void TestThreadPool()
+{
+    ThreadPool pool;
+    std::atomic<int> nCount(0);
+
+    // 多个线程同时向同一个线程池提交任务
+    std::vector<std::thread> vecProducer;
+    for (int i = 0; i < 4; i++)
+    {
+        vecProducer.push_back(std::thread([&pool, &nCount]() {
+            for (int j = 0; j < 1000; j++)
+            {
+                pool.PushThread([&nCount]() { nCount.fetch_add(1); });
+            }
+        }));
+    }
+    for (std::thread &producer : vecProducer)
+    {
+        producer.join();
+    }
+    pool.vWaitAllThreadFinish();
+    assert(nCount.load() == 4000);
+    assert(pool.bIsThreadAllDone());
+
+    // 每批任务都要在vWaitAllThreadFinish返回前执行完
+    nCount.store(0);
+    for (int i = 0; i < 200; i++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            pool.PushThread([&nCount]() { nCount.fetch_add(1); });
+        }
+        pool.vWaitAllThreadFinish();
+        assert(nCount.load() == (i + 1) * 16);
+        assert(pool.bIsThreadAllDone());
+    }
+
+    // 任务未完成时状态为未完成
+    pool.PushThread([]() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+    assert(!pool.bIsThreadAllDone());
+    pool.vWaitAllThreadFinish();
+    assert(pool.bIsThreadAllDone());
+
+    // 成员函数和普通函数都可以提交
+    Test test;
+    test.Run();
+}
+
+// 检查工作线程的临时内存分配器
+void TestArena()
+{
+    // 不在工作线程中时没有分配器
+    assert(ThreadPool::CurrentArena() == nullptr);
+    assert(ThreadPool::CurrentMemoryResource() == std::pmr::get_default_resource());
+
+    ThreadPool pool(2, 1024);
+    auto res = pool.PushThread([]() {
+        ThreadArena *pArena = ThreadPool::CurrentArena();
+        if (pArena == nullptr || pArena->nUsedBytes() != 0)
+        {
+            return false;
+        }
+        // 超过对齐要求和超过普通块大小的分配都要满足对齐
+        void *pAligned = pArena->allocate(100, 256);
+        void *pLarge = pArena->allocate(4096, 64);
+        if (reinterpret_cast<std::uintptr_t>(pAligned) % 256 != 0 ||
+            reinterpret_cast<std::uintptr_t>(pLarge) % 64 != 0)
+        {
+            return false;
+        }
+        std::pmr::vector<int> vec(ThreadPool::CurrentMemoryResource());
+        vec.resize(1000);
+        return pArena->nUsedBytes() > 0;
+    });
+    assert(res.get());
+    pool.vWaitAllThreadFinish();
+
+    // 任务结束后分配器已被重置
+    for (int i = 0; i < 8; i++)
+    {
+        auto used = pool.PushThread([]() { return ThreadPool::CurrentArena()->nUsedBytes(); });
+        assert(used.get() == 0);
+    }
+}
+
+// 检查按key分配和指定线程的任务
+void TestKeyed()
+{
+    const int nThreadNum = 4;
+    const int nKeyNum = 16;
+    ThreadPool pool(nThreadNum);
+
+    // 相同key的任务按提交顺序串行执行，序号只会递增
+    std::vector<int> vecLastSeq(nKeyNum, -1);
+    std::vector<int> vecInOrder(nKeyNum, 1);
+    for (int i = 0; i < 20000; i++)
+    {
+        int nKey = (i % nKeyNum) * nThreadNum;
+        pool.PushKeyed(nKey, [&vecLastSeq, &vecInOrder, i](int nIndex) {
+            if (vecLastSeq[nIndex] >= i)
+            {
+                vecInOrder[nIndex] = 0;
+            }
+            vecLastSeq[nIndex] = i;
+        }, i % nKeyNum);
+        if (i % 7 == 0)
+        {
+            pool.PushThread([]() {});
+        }
+    }
+    pool.vWaitAllThreadFinish();
+    for (int i = 0; i < nKeyNum; i++)
+    {
+        assert(vecInOrder[i]);
+    }
+
+    // 下标超出范围或为负数时对线程总数取模
+    for (int i = 0; i < nThreadNum; i++)
+    {
+        auto getID = []() { return std::this_thread::get_id(); };
+        std::thread::id id = pool.PushThreadOn(i, getID).get();
+        assert(pool.PushThreadOn(i + nThreadNum, getID).get() == id);
+        assert(pool.PushThreadOn(i - nThreadNum, getID).get() == id);
+        assert(pool.PushThreadOn((i + 1) % nThreadNum, getID).get() != id);
+    }
+
+    // 线程数为0时按1个线程处理
+    ThreadPool poolEmpty(0);
+    assert(poolEmpty.PushKeyed(1, []() { return 1; }).get() == 1);
+    assert(poolEmpty.PushThreadOn(3, []() { return 3; }).get() == 3);
+}
+
+// 检查专属队列持续有任务时共享任务不会被饿死
+void TestSharedNotStarved()
+{
+    const int nThreadNum = 2;
+    const int nStepLimit = 20000;
+    ThreadPool pool(nThreadNum);
+    std::atomic<int> nStep(0);
+    std::atomic<int> nSharedStep(-1);
+
+    // 每个工作线程上运行一条不断向自己提交下一步的任务链
+    std::function<void(int)> chain = [&](int nWorker) {
+        int n = nStep.fetch_add(1);
+        if (n == 1000)
+        {
+            pool.PushThread([&nStep, &nSharedStep]() { nSharedStep.store(nStep.load()); });
+        }
+        if (n < nStepLimit)
+        {
+            pool.PushThreadOn(nWorker, chain, nWorker);
+        }
+    };
+    for (int i = 0; i < nThreadNum; i++)
+    {
+        pool.PushThreadOn(i, chain, i);
+    }
+    pool.vWaitAllThreadFinish();
+
+    // 共享任务必须在任务链结束前执行
+    assert(nSharedStep.load() >= 0);
+    assert(nSharedStep.load() < nStepLimit / 2);
+}
+
 int main()
 {
+    TestTwoLockQueue();
+    TestThreadPool();
+    TestArena();
+    TestKeyed();
+    TestSharedNotStarved();
     ThreadPoolLockFree pool;
     for (size_t i = 0; i < 100; i++)
     {